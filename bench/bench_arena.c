@@ -0,0 +1,223 @@
+/* Per frame allocation benchmark.
+ *
+ * Every frame makes a few thousand small allocations, the way a renderer uploads uniforms,
+ * instance data and dynamic vertices, and reports how much CPU time they took.
+ *
+ *   arena      lahar_frame_alloc from the window's frame arena, writing the data into it.
+ *              A frame's allocations are given back together when its flight comes around
+ *   allocator  a buffer per allocation from lahar->gpu_allocator, freed once the frame that
+ *              used it is done. It doesn't write anything, so it only pays for creating,
+ *              binding and freeing the buffers
+ *
+ * The arena starts at a quarter of what a frame needs, so the first frames also show what
+ * growing it costs.
+ *
+ * Usage: bench_arena [allocations per frame] [bytes per allocation] [frames]
+ */
+
+#include "bench_common.h"
+
+#define BENCH_DEFAULT_ALLOCS 2000
+#define BENCH_DEFAULT_SIZE 256
+#define BENCH_DEFAULT_FRAMES 300
+#define BENCH_MAX_FLIGHTS 4
+
+static Lahar lahar;
+
+/** The allocator mode's buffers, per frame in flight, freed when the flight comes around again */
+static VkBuffer* buffers[BENCH_MAX_FLIGHTS];
+static LaharAllocation* allocations[BENCH_MAX_FLIGHTS];
+static uint32_t buffer_counts[BENCH_MAX_FLIGHTS];
+
+static void free_flight(uint32_t flight) {
+    for (uint32_t i = 0; i < buffer_counts[flight]; i++) {
+        lahar.gpu_allocator->free_buffer(lahar.gpu_allocator, &lahar, &buffers[flight][i], &allocations[flight][i]);
+    }
+
+    buffer_counts[flight] = 0;
+}
+
+static uint32_t run_arena(LaharWindowState* state, uint32_t allocs, const uint8_t* payload, uint32_t size) {
+    LaharFrameAlloc alloc;
+    uint32_t err;
+
+    for (uint32_t i = 0; i < allocs; i++) {
+        if ((err = lahar_frame_alloc(&lahar, state, size, 0, &alloc))) {
+            return err;
+        }
+
+        memcpy(alloc.data, payload, size);
+    }
+
+    return LAHAR_ERR_SUCCESS;
+}
+
+static uint32_t run_allocator(LaharWindowState* state, uint32_t allocs, uint32_t size) {
+    uint32_t flight = state->flight_index;
+    uint32_t err;
+    VkBufferCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    for (uint32_t i = 0; i < allocs; i++) {
+        if ((err = lahar.gpu_allocator->alloc_buffer(lahar.gpu_allocator, &lahar, &info,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &buffers[flight][i], &allocations[flight][i]))) {
+            return err;
+        }
+
+        buffer_counts[flight]++;
+    }
+
+    return LAHAR_ERR_SUCCESS;
+}
+
+/** Present the frame, with a command buffer that only gets the image ready for it */
+static uint32_t finish_frame(LaharHeadlessWindow* window, LaharWindowState* state) {
+    VkCommandBuffer cmd = state->commands[state->flight_index];
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    uint32_t err;
+
+    vkResetCommandBuffer(cmd, 0);
+    vkBeginCommandBuffer(cmd, &begin_info);
+    lahar_window_attachment_transition(&lahar, window, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, cmd);
+    vkEndCommandBuffer(cmd);
+
+    if ((err = lahar_window_submit(&lahar, window, cmd))) {
+        return err;
+    }
+
+    return lahar_window_present(&lahar, window);
+}
+
+int main(int argc, char** argv) {
+    uint32_t allocs = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_ALLOCS;
+    uint32_t size = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_SIZE;
+    uint32_t frames = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : BENCH_DEFAULT_FRAMES;
+    LaharHeadlessWindow window = { 256, 256 };
+    uint8_t* payload = NULL;
+    uint32_t err;
+    int ret = 1;
+
+    if (allocs == 0 || size == 0 || frames == 0) {
+        fprintf(stderr, "usage: %s [allocations per frame] [bytes per allocation] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    if ((err = lahar_init(&lahar))) {
+        fprintf(stderr, "lahar_init failed: %s\n", lahar_err_name(err));
+        return 1;
+    }
+
+    lahar_builder_request_command_buffers(&lahar);
+
+    LaharAttachmentConfig color = {0};
+    LaharWindowConfig config = {
+        .attachment_count = 1,
+        .attachments = &color,
+        .frame_arena_size = (VkDeviceSize)allocs * size / 4,
+    };
+
+    if ((err = lahar_builder_window_register_ex(&lahar, &window, &config))) {
+        fprintf(stderr, "lahar_builder_window_register_ex failed: %s\n", lahar_err_name(err));
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    if ((err = lahar_build(&lahar))) {
+        fprintf(stderr, "lahar_build failed: %s (VkResult %d)\n", lahar_err_name(err), (int)lahar.vkresult);
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    LaharWindowState* state = lahar_window_state(&lahar, &window);
+
+    const char* names[2] = { "arena", "allocator" };
+    uint64_t* samples[2];
+    for (int m = 0; m < 2; m++) {
+        samples[m] = (uint64_t*)malloc(frames * sizeof(uint64_t));
+    }
+
+    bool out_of_memory = !samples[0] || !samples[1];
+    for (uint32_t f = 0; f < BENCH_MAX_FLIGHTS; f++) {
+        buffers[f] = (VkBuffer*)malloc(allocs * sizeof(VkBuffer));
+        allocations[f] = (LaharAllocation*)malloc(allocs * sizeof(LaharAllocation));
+        out_of_memory = out_of_memory || !buffers[f] || !allocations[f];
+    }
+
+    payload = (uint8_t*)calloc(size, 1);
+
+    if (out_of_memory || !payload) {
+        fprintf(stderr, "out of memory\n");
+        goto end;
+    }
+
+    if (!lahar.gpu_allocator || !lahar.gpu_allocator->alloc_buffer || state->max_in_flight > BENCH_MAX_FLIGHTS) {
+        fprintf(stderr, "lahar has no buffer allocator to compare against\n");
+        goto end;
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        for (int m = 0; m < 2; m++) {
+            if ((err = lahar_window_frame_begin(&lahar, &window))) {
+                fprintf(stderr, "lahar_window_frame_begin failed: %s\n", lahar_err_name(err));
+                goto end;
+            }
+
+            uint64_t start = bench_now_ns();
+
+            if (m == 0) {
+                err = run_arena(state, allocs, payload, size);
+            }
+            else {
+                free_flight(state->flight_index);
+                err = run_allocator(state, allocs, size);
+            }
+
+            samples[m][f] = bench_now_ns() - start;
+
+            if (err || (err = finish_frame(&window, state))) {
+                fprintf(stderr, "%s frame %u failed: %s (VkResult %d)\n", names[m], f, lahar_err_name(err), (int)lahar.vkresult);
+                goto end;
+            }
+        }
+    }
+
+    printf("device: %s\n", lahar.physdev_info.properties.deviceName);
+    printf("%u allocations of %u bytes, %u frames, arena grew %u times to %llu bytes per frame%s\n\n",
+        allocs, size, frames, state->frame_arena.grow_count, (unsigned long long)state->frame_arena.region_size,
+        (state->frame_arena.memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ? " in device local memory" : "");
+    bench_report_header("us", "ns/alloc");
+
+    for (int m = 0; m < 2; m++) {
+        bench_report(names[m], samples[m], frames, 1000.0, allocs);
+    }
+
+    ret = 0;
+
+end:
+    lahar_window_wait_inactive(&lahar, &window);
+
+    for (uint32_t f = 0; f < BENCH_MAX_FLIGHTS; f++) {
+        if (buffers[f] && allocations[f]) {
+            free_flight(f);
+        }
+
+        free(buffers[f]);
+        free(allocations[f]);
+    }
+
+    for (int m = 0; m < 2; m++) {
+        free(samples[m]);
+    }
+
+    free(payload);
+    lahar_deinit(&lahar);
+    return ret;
+}
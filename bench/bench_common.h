@@ -0,0 +1,126 @@
+/* Shared scaffolding for the lahar benchmarks.
+ *
+ * The benchmarks run without a window system. They use lahar's headless windows, backed
+ * by VK_EXT_headless_surface, so any driver exposing that extension (mesa's lavapipe,
+ * SwiftShader, most desktop drivers) can run them, including on CI machines.
+ *
+ * Benchmarks comparing several modes interleave them, taking one sample of each in turn, so
+ * clock drift and driver warmup hit all of them equally.
+ *
+ * Include this in exactly one source file; it pulls in the lahar implementation.
+ */
+
+#ifndef LAHAR_BENCH_COMMON_H
+#define LAHAR_BENCH_COMMON_H
+
+#if !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+    #include <time.h>
+#endif
+
+#define LAHAR_USE_HEADLESS
+#define LAHAR_IMPLEMENTATION
+#include "lahar.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
+/** Monotonic clock in nanoseconds */
+static inline uint64_t bench_now_ns(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/** qsort comparison for samples */
+static inline int bench_cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/** The sample percent of the way from the fastest to the slowest. The samples have to be sorted */
+static inline uint64_t bench_percentile(const uint64_t* samples, uint32_t count, uint32_t percent) {
+    return samples[((uint64_t)(count - 1) * percent) / 100];
+}
+
+/** The column titles for bench_report. per names the extra column, NULL to leave it out */
+static inline void bench_report_header(const char* unit, const char* per) {
+    char titles[4][32];
+    const char* stats[4] = { "min", "p50", "p99", "worst" };
+
+    for (int i = 0; i < 4; i++) {
+        snprintf(titles[i], sizeof(titles[i]), "%s %s", stats[i], unit);
+    }
+
+    printf("%-12s %14s %14s %14s %14s", "mode", titles[0], titles[1], titles[2], titles[3]);
+
+    if (per) {
+        char title[32];
+        snprintf(title, sizeof(title), "p50 %s", per);
+        printf(" %14s", title);
+    }
+
+    printf("\n");
+}
+
+/** Sort the samples and print a row of their percentiles, divided by scale. If per isn't 0 the row
+ * ends with the median divided by per, in the samples' own unit */
+static inline void bench_report(const char* name, uint64_t* samples, uint32_t count, double scale, double per) {
+    qsort(samples, count, sizeof(uint64_t), bench_cmp_u64);
+    printf("%-12s %14.3f %14.3f %14.3f %14.3f", name,
+        (double)samples[0] / scale,
+        (double)bench_percentile(samples, count, 50) / scale,
+        (double)bench_percentile(samples, count, 99) / scale,
+        (double)samples[count - 1] / scale);
+
+    if (per) {
+        printf(" %14.3f", (double)bench_percentile(samples, count, 50) / per);
+    }
+
+    printf("\n");
+}
+
+/** If set, bench_lahar_start has lahar cache its device selection in this file */
+static const char* bench_device_cache = NULL;
+
+/** Init and build lahar with a single headless window. Prints and returns the error on failure. */
+static inline uint32_t bench_lahar_start(Lahar* lahar, LaharHeadlessWindow* window) {
+    uint32_t err;
+
+    if ((err = lahar_init(lahar))) {
+        fprintf(stderr, "lahar_init failed: %s\n", lahar_err_name(err));
+        return err;
+    }
+
+    lahar_builder_request_command_buffers(lahar);
+
+    if (bench_device_cache && (err = lahar_builder_device_cache(lahar, bench_device_cache))) {
+        fprintf(stderr, "lahar_builder_device_cache failed: %s\n", lahar_err_name(err));
+        lahar_deinit(lahar);
+        return err;
+    }
+
+    if ((err = lahar_builder_window_register(lahar, window, LAHAR_WINPROF_COLOR))) {
+        fprintf(stderr, "lahar_builder_window_register failed: %s\n", lahar_err_name(err));
+        lahar_deinit(lahar);
+        return err;
+    }
+
+    if ((err = lahar_build(lahar))) {
+        fprintf(stderr, "lahar_build failed: %s (VkResult %d)\n", lahar_err_name(err), (int)lahar->vkresult);
+        lahar_deinit(lahar);
+        return err;
+    }
+
+    return LAHAR_ERR_SUCCESS;
+}
+
+#endif // LAHAR_BENCH_COMMON_H
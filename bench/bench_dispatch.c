@@ -0,0 +1,122 @@
+/* Dispatch overhead microbenchmark.
+ *
+ * Records the same stream of vkCmdSetViewport/vkCmdSetScissor calls through three
+ * different kinds of function pointer and reports the cost per call:
+ *
+ *   global      the PFN_vk* globals filled by lahar_load_device (vkGetDeviceProcAddr)
+ *   table       lahar->device_table, filled by lahar_load_device_table (vkGetDeviceProcAddr)
+ *   trampoline  the entry points exported by the vulkan loader itself (dlsym/GetProcAddress),
+ *               which look up the device's dispatch table on every call
+ *
+ * Usage: bench_dispatch [calls per batch] [batches]
+ */
+
+#include "bench_common.h"
+
+#define BENCH_DEFAULT_CALLS 20000
+#define BENCH_DEFAULT_BATCHES 200
+
+typedef struct DispatchMode {
+    const char* name;
+    PFN_vkCmdSetViewport set_viewport;
+    PFN_vkCmdSetScissor set_scissor;
+} DispatchMode;
+
+static Lahar lahar;
+
+/* The globals and the table are read through at every call site, like they would be in
+ * a renderer, instead of being hoisted into locals. */
+static uint64_t run_global(VkCommandBuffer cmd, uint32_t calls, const VkViewport* vp, const VkRect2D* sc) {
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < calls; i += 2) {
+        vkCmdSetViewport(cmd, 0, 1, vp);
+        vkCmdSetScissor(cmd, 0, 1, sc);
+    }
+    return bench_now_ns() - start;
+}
+
+static uint64_t run_table(VkCommandBuffer cmd, uint32_t calls, const VkViewport* vp, const VkRect2D* sc) {
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < calls; i += 2) {
+        lahar.device_table.vkCmdSetViewport(cmd, 0, 1, vp);
+        lahar.device_table.vkCmdSetScissor(cmd, 0, 1, sc);
+    }
+    return bench_now_ns() - start;
+}
+
+static uint64_t run_fnptr(const DispatchMode* mode, VkCommandBuffer cmd, uint32_t calls, const VkViewport* vp, const VkRect2D* sc) {
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < calls; i += 2) {
+        mode->set_viewport(cmd, 0, 1, vp);
+        mode->set_scissor(cmd, 0, 1, sc);
+    }
+    return bench_now_ns() - start;
+}
+
+int main(int argc, char** argv) {
+    uint32_t calls = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_CALLS;
+    uint32_t batches = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_BATCHES;
+    LaharHeadlessWindow window = { 256, 256 };
+
+    if (calls < 2 || batches == 0) {
+        fprintf(stderr, "usage: %s [calls per batch] [batches]\n", argv[0]);
+        return 1;
+    }
+
+    if (bench_lahar_start(&lahar, &window)) {
+        return 1;
+    }
+
+    DispatchMode trampoline = {
+        .name = "trampoline",
+        .set_viewport = (PFN_vkCmdSetViewport)lahar_loader_sym(&lahar, "vkCmdSetViewport"),
+        .set_scissor = (PFN_vkCmdSetScissor)lahar_loader_sym(&lahar, "vkCmdSetScissor"),
+    };
+
+    if (!trampoline.set_viewport || !trampoline.set_scissor || !lahar.device_table.vkCmdSetViewport) {
+        fprintf(stderr, "failed to resolve the benchmark entry points\n");
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    VkCommandBuffer cmd = lahar_window_state(&lahar, &window)->commands[0];
+    VkViewport viewport = { 0.0f, 0.0f, 256.0f, 256.0f, 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, { 256, 256 } };
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    const char* names[3] = { "global", "table", "trampoline" };
+    uint64_t* samples[3];
+    for (int m = 0; m < 3; m++) {
+        samples[m] = (uint64_t*)malloc(batches * sizeof(uint64_t));
+    }
+
+    for (uint32_t b = 0; b < batches; b++) {
+        for (int m = 0; m < 3; m++) {
+            vkResetCommandBuffer(cmd, 0);
+            vkBeginCommandBuffer(cmd, &begin_info);
+
+            switch (m) {
+                case 0: samples[m][b] = run_global(cmd, calls, &viewport, &scissor); break;
+                case 1: samples[m][b] = run_table(cmd, calls, &viewport, &scissor); break;
+                default: samples[m][b] = run_fnptr(&trampoline, cmd, calls, &viewport, &scissor); break;
+            }
+
+            vkEndCommandBuffer(cmd);
+        }
+    }
+
+    printf("device: %s\n", lahar.physdev_info.properties.deviceName);
+    printf("%u calls x %u batches\n\n", calls, batches);
+    bench_report_header("ns/call", NULL);
+
+    for (int m = 0; m < 3; m++) {
+        bench_report(names[m], samples[m], batches, calls, 0);
+        free(samples[m]);
+    }
+
+    lahar_deinit(&lahar);
+    return 0;
+}
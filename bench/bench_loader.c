@@ -0,0 +1,65 @@
+/* Entry point loading benchmark.
+ *
+ * Re-runs lahar's instance, device and device table loaders against an already built
+ * lahar, so the numbers only cover resolving entry points and storing them, not creating
+ * the instance or device. Pair it with `size` on the binary to see what the loaders
+ * cost in code and data.
+ *
+ * Usage: bench_loader [iterations]
+ */
+
+#include "bench_common.h"
+
+#define BENCH_DEFAULT_ITERATIONS 200
+
+static Lahar lahar;
+
+int main(int argc, char** argv) {
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_ITERATIONS;
+    LaharHeadlessWindow window = { 256, 256 };
+
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    if (bench_lahar_start(&lahar, &window)) {
+        return 1;
+    }
+
+    uint64_t* samples[3];
+    for (int m = 0; m < 3; m++) {
+        samples[m] = (uint64_t*)malloc(iterations * sizeof(uint64_t));
+    }
+
+    LaharDeviceTable table;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t start = bench_now_ns();
+        lahar_load_instance(&lahar, __lahar_loader_inst);
+        uint64_t instance = bench_now_ns();
+        lahar_load_device(&lahar, __lahar_loader_dev);
+        uint64_t device = bench_now_ns();
+        lahar_load_device_table(&lahar, lahar.device, &table);
+        uint64_t end = bench_now_ns();
+
+        samples[0][i] = instance - start;
+        samples[1][i] = device - instance;
+        samples[2][i] = end - device;
+    }
+
+    printf("device: %s\n", lahar.physdev_info.properties.deviceName);
+    printf("%u iterations\n\n", iterations);
+    bench_report_header("us", NULL);
+
+    bench_report("instance", samples[0], iterations, 1000.0, 0);
+    bench_report("device", samples[1], iterations, 1000.0, 0);
+    bench_report("device_table", samples[2], iterations, 1000.0, 0);
+
+    for (int m = 0; m < 3; m++) {
+        free(samples[m]);
+    }
+
+    lahar_deinit(&lahar);
+    return 0;
+}
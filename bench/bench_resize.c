@@ -0,0 +1,188 @@
+/* Resize storm benchmark.
+ *
+ * Renders frames into a single headless window while changing its size every few frames,
+ * the way dragging a window edge does, and reports how long each frame took including
+ * the swapchain recreation. Every frame clears the swapchain image and the depth buffer
+ * so there is real work in flight when the resize lands.
+ *
+ *   drain     the way lahar resized before it deferred anything: wait for the window's
+ *             frames to finish, destroy the swapchain and every attachment, then create
+ *             them all again without an old swapchain to hand over from
+ *   deferred  lahar's resizer, which resizes straight away and retires the old swapchain
+ *             once the frames that used it have finished
+ *
+ * The worst frame is the number to watch, it is the hitch a user sees while resizing.
+ *
+ * Usage: bench_resize [frames] [frames between resizes]
+ */
+
+#include "bench_common.h"
+
+#define BENCH_DEFAULT_FRAMES 600
+#define BENCH_DEFAULT_INTERVAL 2
+
+static Lahar lahar;
+
+/** Record and present one frame that clears the color and depth attachments */
+static uint32_t run_frame(LaharHeadlessWindow* window) {
+    uint32_t err;
+
+    if ((err = lahar_window_frame_begin(&lahar, window))) {
+        return err;
+    }
+
+    LaharWindowState* state = lahar_window_state(&lahar, window);
+    VkCommandBuffer cmd = state->commands[state->flight_index];
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkClearColorValue color = { { 0.1f, 0.2f, 0.3f, 1.0f } };
+    VkClearDepthStencilValue depth = { 1.0f, 0 };
+    VkImageSubresourceRange color_range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    VkImageSubresourceRange depth_range = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+    vkResetCommandBuffer(cmd, 0);
+    vkBeginCommandBuffer(cmd, &begin_info);
+
+    lahar_window_attachment_transition(&lahar, window, 0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, cmd);
+    lahar_window_attachment_transition(&lahar, window, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, cmd);
+    vkCmdClearColorImage(cmd, lahar_window_attachment(state, 0)->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &color_range);
+    vkCmdClearDepthStencilImage(cmd, lahar_window_attachment(state, 1)->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &depth, 1, &depth_range);
+    lahar_window_attachment_transition(&lahar, window, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, cmd);
+
+    vkEndCommandBuffer(cmd);
+
+    if ((err = lahar_window_submit(&lahar, window, cmd))) {
+        return err;
+    }
+
+    return lahar_window_present(&lahar, window);
+}
+
+/** Resize like lahar did before swapchains were retired, as a window resize callback. The bench includes
+ * lahar's implementation, so it can tear the window down with lahar's own helpers. With nothing left to
+ * retire, the default resizer then creates everything from scratch */
+static uint32_t drain_resizer(Lahar* lahar, LaharWindow* window) {
+    LaharWindowState* state = lahar_window_state(lahar, window);
+    uint32_t err;
+
+    if ((err = lahar_window_wait_inactive(lahar, window))) {
+        return err;
+    }
+
+    __lahar_attachments_destroy(lahar, state, state->attachments, state->swap_size);
+    lahar_dispatch(lahar, vkDestroySwapchainKHR)(lahar->device, state->swapchain, lahar->vkalloc);
+
+    state->attachments = NULL;
+    state->swapchain = VK_NULL_HANDLE;
+    state->swap_size = 0;
+
+    return __lahar_default_resizer(lahar, window);
+}
+
+/** Run the storm once, writing one sample per frame */
+static int run_storm(LaharHeadlessWindow* window, bool drain, uint64_t* out, uint32_t frames, uint32_t interval) {
+    uint32_t err;
+
+    lahar_window_state(&lahar, window)->resize_callback = drain ? drain_resizer : NULL;
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint64_t start = bench_now_ns();
+
+        if (f % interval == 0) {
+            // Sweep back and forth over a range of sizes so the attachments get reallocated
+            uint32_t step = (f / interval) % 64;
+            uint32_t grow = step < 32 ? step : 63 - step;
+            window->width = 320 + grow * 24;
+            window->height = 240 + grow * 16;
+
+            if ((err = lahar_window_swapchain_resize(&lahar, window))) {
+                fprintf(stderr, "lahar_window_swapchain_resize failed: %s (VkResult %d)\n", lahar_err_name(err), (int)lahar.vkresult);
+                return 1;
+            }
+        }
+
+        if ((err = run_frame(window))) {
+            fprintf(stderr, "frame %u failed: %s (VkResult %d)\n", f, lahar_err_name(err), (int)lahar.vkresult);
+            return 1;
+        }
+
+        out[f] = bench_now_ns() - start;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_FRAMES;
+    uint32_t interval = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_INTERVAL;
+    LaharHeadlessWindow window = { 320, 240 };
+    uint32_t err;
+    int ret = 1;
+
+    if (frames == 0 || interval == 0) {
+        fprintf(stderr, "usage: %s [frames] [frames between resizes]\n", argv[0]);
+        return 1;
+    }
+
+    // bench_lahar_start only asks for a color attachment, the storm wants a depth buffer too
+    if ((err = lahar_init(&lahar))) {
+        fprintf(stderr, "lahar_init failed: %s\n", lahar_err_name(err));
+        return 1;
+    }
+
+    lahar_builder_request_command_buffers(&lahar);
+
+    if ((err = lahar_builder_window_register(&lahar, &window, LAHAR_WINPROF_COLOR_DEPTH))) {
+        fprintf(stderr, "lahar_builder_window_register failed: %s\n", lahar_err_name(err));
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    // Clearing needs transfer usage on both attachments, which the profile leaves out
+    LaharWindowState* state = lahar_window_state(&lahar, &window);
+    state->attachment_configs[0].usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    state->attachment_configs[1].img_info.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    if ((err = lahar_build(&lahar))) {
+        fprintf(stderr, "lahar_build failed: %s (VkResult %d)\n", lahar_err_name(err), (int)lahar.vkresult);
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    const char* names[2] = { "drain", "deferred" };
+    uint64_t* samples[2];
+    for (int m = 0; m < 2; m++) {
+        samples[m] = (uint64_t*)malloc(frames * sizeof(uint64_t));
+    }
+
+    if (!samples[0] || !samples[1]) {
+        fprintf(stderr, "out of memory\n");
+        goto end;
+    }
+
+    for (int m = 0; m < 2; m++) {
+        if (run_storm(&window, m == 0, samples[m], frames, interval)) {
+            goto end;
+        }
+    }
+
+    printf("device: %s\n", lahar.physdev_info.properties.deviceName);
+    printf("%u frames, resizing every %u\n\n", frames, interval);
+    bench_report_header("ms", NULL);
+
+    for (int m = 0; m < 2; m++) {
+        bench_report(names[m], samples[m], frames, 1e6, 0);
+    }
+
+    ret = 0;
+
+end:
+    for (int m = 0; m < 2; m++) {
+        free(samples[m]);
+    }
+
+    lahar_deinit(&lahar);
+    return ret;
+}
@@ -0,0 +1,215 @@
+/* Startup benchmark.
+ *
+ * Times lahar_init + lahar_build + lahar_deinit with a single headless window, broken
+ * down by the phases in lahar->build_stats, and prints percentiles as JSON so the
+ * output can be archived and diffed between commits.
+ *
+ *   cold  every cycle runs in a fresh child process, so it pays for loading the vulkan
+ *         loader, the ICD and the driver's own first time setup
+ *   warm  cycles repeated inside this process after one untimed warmup cycle
+ *
+ * With a device cache file every cycle passes it to lahar_builder_device_cache, so after
+ * the first cycle the physdev phase shows the cached path. Delete the file between runs
+ * to compare against the full device selection.
+ *
+ * To run it without a GPU point the loader at lavapipe (or any other software ICD):
+ *   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json bench_startup
+ *
+ * Usage: bench_startup [cold cycles] [warm cycles] [device cache file]
+ */
+
+#include "bench_common.h"
+
+#if defined(_WIN32)
+    #define popen _popen
+    #define pclose _pclose
+#endif
+
+#define BENCH_DEFAULT_COLD 20
+#define BENCH_DEFAULT_WARM 50
+
+#define BENCH_CHILD_FLAG "--child"
+
+typedef struct StartupPhase {
+    const char* name;
+    size_t offset;      // Into LaharBuildStats, or SIZE_MAX for the ones timed here
+} StartupPhase;
+
+static const StartupPhase phases[] = {
+    { "dlopen", offsetof(LaharBuildStats, dlopen_ns) },
+    { "load_loader", offsetof(LaharBuildStats, load_loader_ns) },
+    { "inst_extensions", offsetof(LaharBuildStats, inst_extensions_ns) },
+    { "instance", offsetof(LaharBuildStats, instance_ns) },
+    { "early_surface", offsetof(LaharBuildStats, early_surface_ns) },
+    { "physdev", offsetof(LaharBuildStats, physdev_ns) },
+    { "device", offsetof(LaharBuildStats, device_ns) },
+    { "swapchain", offsetof(LaharBuildStats, swapchain_ns) },
+    { "sync", offsetof(LaharBuildStats, sync_ns) },
+    { "build", offsetof(LaharBuildStats, build_ns) },
+    { "init_build", SIZE_MAX },
+    { "deinit", SIZE_MAX },
+};
+
+#define PHASE_COUNT (sizeof(phases) / sizeof(phases[0]))
+#define PHASE_INIT_BUILD (PHASE_COUNT - 2)
+#define PHASE_DEINIT (PHASE_COUNT - 1)
+
+static char device_name[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+
+/** One init/build/deinit cycle, writing PHASE_COUNT samples to out */
+static int run_cycle(uint64_t* out) {
+    static Lahar lahar;
+    LaharHeadlessWindow window = { 256, 256 };
+
+    uint64_t start = bench_now_ns();
+
+    if (bench_lahar_start(&lahar, &window)) {
+        return 1;
+    }
+
+    uint64_t built = bench_now_ns();
+
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        if (phases[i].offset != SIZE_MAX) {
+            out[i] = *(const uint64_t*)((const char*)&lahar.build_stats + phases[i].offset);
+        }
+    }
+
+    memcpy(device_name, lahar.physdev_info.properties.deviceName, sizeof(device_name));
+
+    lahar_deinit(&lahar);
+
+    out[PHASE_INIT_BUILD] = built - start;
+    out[PHASE_DEINIT] = bench_now_ns() - built;
+    return 0;
+}
+
+/** Run a cold cycle by re-launching ourselves, and parse the samples it prints */
+static int run_cold(const char* self, uint64_t* out) {
+    char cmd[4096];
+
+    if (bench_device_cache) {
+        snprintf(cmd, sizeof(cmd), "\"%s\" %s \"%s\"", self, BENCH_CHILD_FLAG, bench_device_cache);
+    }
+    else {
+        snprintf(cmd, sizeof(cmd), "\"%s\" %s", self, BENCH_CHILD_FLAG);
+    }
+
+    FILE* child = popen(cmd, "r");
+    if (!child) {
+        return 1;
+    }
+
+    int parsed = 0;
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        unsigned long long value;
+        if (fscanf(child, "%llu", &value) != 1) { break; }
+        out[i] = (uint64_t)value;
+        parsed++;
+    }
+
+    return (pclose(child) != 0 || parsed != (int)PHASE_COUNT) ? 1 : 0;
+}
+
+static void print_set(const char* name, uint64_t* samples, uint32_t runs, bool last) {
+    printf("  \"%s\": {\n", name);
+
+    for (size_t p = 0; p < PHASE_COUNT; p++) {
+        uint64_t* column = &samples[p * runs];
+        qsort(column, runs, sizeof(uint64_t), bench_cmp_u64);
+
+        printf("    \"%s\": { \"min\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu }%s\n",
+            phases[p].name,
+            (unsigned long long)column[0],
+            (unsigned long long)bench_percentile(column, runs, 50),
+            (unsigned long long)bench_percentile(column, runs, 90),
+            (unsigned long long)bench_percentile(column, runs, 99),
+            (unsigned long long)column[runs - 1],
+            p + 1 < PHASE_COUNT ? "," : "");
+    }
+
+    printf("  }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+    uint64_t cycle[PHASE_COUNT];
+
+    if (argc > 1 && strcmp(argv[1], BENCH_CHILD_FLAG) == 0) {
+        bench_device_cache = argc > 2 ? argv[2] : NULL;
+
+        if (run_cycle(cycle)) {
+            return 1;
+        }
+
+        for (size_t i = 0; i < PHASE_COUNT; i++) {
+            printf("%llu ", (unsigned long long)cycle[i]);
+        }
+
+        printf("\n");
+        return 0;
+    }
+
+    uint32_t cold = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_COLD;
+    uint32_t warm = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_WARM;
+    bench_device_cache = argc > 3 ? argv[3] : NULL;
+
+    if (cold == 0 || warm == 0) {
+        fprintf(stderr, "usage: %s [cold cycles] [warm cycles] [device cache file]\n", argv[0]);
+        return 1;
+    }
+
+    // Samples are stored phase major, so each phase can be sorted in place
+    uint64_t* cold_samples = (uint64_t*)malloc(PHASE_COUNT * cold * sizeof(uint64_t));
+    uint64_t* warm_samples = (uint64_t*)malloc(PHASE_COUNT * warm * sizeof(uint64_t));
+    int ret = 1;
+
+    if (!cold_samples || !warm_samples) {
+        fprintf(stderr, "out of memory\n");
+        goto end;
+    }
+
+    for (uint32_t r = 0; r < cold; r++) {
+        if (run_cold(argv[0], cycle)) {
+            fprintf(stderr, "cold cycle %u failed\n", r);
+            goto end;
+        }
+
+        for (size_t p = 0; p < PHASE_COUNT; p++) {
+            cold_samples[p * cold + r] = cycle[p];
+        }
+    }
+
+    if (run_cycle(cycle)) {
+        goto end;
+    }
+
+    for (uint32_t r = 0; r < warm; r++) {
+        if (run_cycle(cycle)) {
+            fprintf(stderr, "warm cycle %u failed\n", r);
+            goto end;
+        }
+
+        for (size_t p = 0; p < PHASE_COUNT; p++) {
+            warm_samples[p * warm + r] = cycle[p];
+        }
+    }
+
+    printf("{\n");
+    printf("  \"device\": \"%s\",\n", device_name);
+    printf("  \"unit\": \"ns\",\n");
+    if (bench_device_cache) {
+        printf("  \"device_cache\": \"%s\",\n", bench_device_cache);
+    }
+    printf("  \"cold_cycles\": %u,\n", cold);
+    printf("  \"warm_cycles\": %u,\n", warm);
+    print_set("cold", cold_samples, cold, false);
+    print_set("warm", warm_samples, warm, true);
+    printf("}\n");
+
+    ret = 0;
+
+end:
+    free(cold_samples);
+    free(warm_samples);
+    return ret;
+}
@@ -0,0 +1,173 @@
+/* Multi-window frame benchmark.
+ *
+ * Renders frames into several headless windows at once and reports how much CPU time a
+ * frame of all of them took, from beginning the frames to presenting the last window.
+ * Every window's frame only moves its swapchain image to PRESENT_SRC, so the numbers are
+ * mostly lahar's and the driver's per-call overhead.
+ *
+ *   single   lahar_window_frame_begin, lahar_window_submit and lahar_window_present on
+ *            each window in turn, one vkQueueSubmit and one vkQueuePresentKHR per window
+ *   batched  lahar_frame_begin_all, lahar_submit_windows and lahar_present_all, one
+ *            vkQueueSubmit and one vkQueuePresentKHR for every window together
+ *
+ * The windows use LaharWindowConfig.timeline_sync when lahar has timeline semaphores, so
+ * the batched submit doesn't need an extra call per window for its fence.
+ *
+ * Usage: bench_windows [windows] [frames]
+ */
+
+#include "bench_common.h"
+
+#define BENCH_DEFAULT_WINDOWS 8
+#define BENCH_DEFAULT_FRAMES 500
+#define BENCH_MAX_WINDOWS 64
+
+static Lahar lahar;
+static LaharHeadlessWindow windows[BENCH_MAX_WINDOWS];
+static LaharWindow* window_list[BENCH_MAX_WINDOWS];
+static LaharWindowSubmit submits[BENCH_MAX_WINDOWS];
+static VkCommandBuffer cmds[BENCH_MAX_WINDOWS];
+
+/** Record the window's command buffer for the frame it just began */
+static VkCommandBuffer record(LaharHeadlessWindow* window) {
+    LaharWindowState* state = lahar_window_state(&lahar, window);
+    VkCommandBuffer cmd = state->commands[state->flight_index];
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    vkResetCommandBuffer(cmd, 0);
+    vkBeginCommandBuffer(cmd, &begin_info);
+    lahar_window_attachment_transition(&lahar, window, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, cmd);
+    vkEndCommandBuffer(cmd);
+
+    return cmd;
+}
+
+static uint32_t run_single(uint32_t window_count) {
+    uint32_t err;
+
+    for (uint32_t w = 0; w < window_count; w++) {
+        if ((err = lahar_window_frame_begin(&lahar, &windows[w]))) {
+            return err;
+        }
+
+        if ((err = lahar_window_submit(&lahar, &windows[w], record(&windows[w])))) {
+            return err;
+        }
+
+        if ((err = lahar_window_present(&lahar, &windows[w]))) {
+            return err;
+        }
+    }
+
+    return LAHAR_ERR_SUCCESS;
+}
+
+static uint32_t run_batched(uint32_t window_count) {
+    uint32_t err;
+
+    if ((err = lahar_frame_begin_all(&lahar, window_list, window_count, NULL))) {
+        return err;
+    }
+
+    for (uint32_t w = 0; w < window_count; w++) {
+        cmds[w] = record(&windows[w]);
+    }
+
+    if ((err = lahar_submit_windows(&lahar, submits, window_count, NULL))) {
+        return err;
+    }
+
+    return lahar_present_all(&lahar, window_list, window_count, NULL);
+}
+
+int main(int argc, char** argv) {
+    uint32_t window_count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_WINDOWS;
+    uint32_t frames = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_FRAMES;
+    uint32_t err;
+    int ret = 1;
+
+    if (window_count == 0 || window_count > BENCH_MAX_WINDOWS || frames == 0) {
+        fprintf(stderr, "usage: %s [windows, at most %d] [frames]\n", argv[0], BENCH_MAX_WINDOWS);
+        return 1;
+    }
+
+    if ((err = lahar_init(&lahar))) {
+        fprintf(stderr, "lahar_init failed: %s\n", lahar_err_name(err));
+        return 1;
+    }
+
+    lahar_builder_request_command_buffers(&lahar);
+
+    LaharAttachmentConfig color = {0};
+    LaharWindowConfig config = {
+        .attachment_count = 1,
+        .attachments = &color,
+        .timeline_sync = LAHAR_HAS_TIMELINE_SEMAPHORES,
+    };
+
+    for (uint32_t w = 0; w < window_count; w++) {
+        windows[w].width = 256;
+        windows[w].height = 256;
+        window_list[w] = &windows[w];
+        submits[w].window = &windows[w];
+        submits[w].cmds = &cmds[w];
+        submits[w].cmd_count = 1;
+
+        if ((err = lahar_builder_window_register_ex(&lahar, &windows[w], &config))) {
+            fprintf(stderr, "lahar_builder_window_register_ex failed: %s\n", lahar_err_name(err));
+            lahar_deinit(&lahar);
+            return 1;
+        }
+    }
+
+    if ((err = lahar_build(&lahar))) {
+        fprintf(stderr, "lahar_build failed: %s (VkResult %d)\n", lahar_err_name(err), (int)lahar.vkresult);
+        lahar_deinit(&lahar);
+        return 1;
+    }
+
+    const char* names[2] = { "single", "batched" };
+    uint64_t* samples[2];
+    for (int m = 0; m < 2; m++) {
+        samples[m] = (uint64_t*)malloc(frames * sizeof(uint64_t));
+    }
+
+    if (!samples[0] || !samples[1]) {
+        fprintf(stderr, "out of memory\n");
+        goto end;
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        for (int m = 0; m < 2; m++) {
+            uint64_t start = bench_now_ns();
+            err = m == 0 ? run_single(window_count) : run_batched(window_count);
+            samples[m][f] = bench_now_ns() - start;
+
+            if (err) {
+                fprintf(stderr, "%s frame %u failed: %s (VkResult %d)\n", names[m], f, lahar_err_name(err), (int)lahar.vkresult);
+                goto end;
+            }
+        }
+    }
+
+    printf("device: %s\n", lahar.physdev_info.properties.deviceName);
+    printf("%u windows, %u frames, %s\n\n", window_count, frames, LAHAR_HAS_TIMELINE_SEMAPHORES ? "timeline sync" : "fences");
+    bench_report_header("us", "ns/window");
+
+    for (int m = 0; m < 2; m++) {
+        bench_report(names[m], samples[m], frames, 1000.0, window_count);
+    }
+
+    ret = 0;
+
+end:
+    for (int m = 0; m < 2; m++) {
+        free(samples[m]);
+    }
+
+    lahar_deinit(&lahar);
+    return ret;
+}
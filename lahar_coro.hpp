@@ -0,0 +1,174 @@
+/* Lahar is licensed under the permissive zlib license. See the bottom of the file for details. */
+
+#ifndef LAHAR_CORO_HPP
+#define LAHAR_CORO_HPP
+
+/*
+
+C++20 coroutine support for lahar. Optional, and only needs lahar.h.
+
+Lets a coroutine co_await the start of a window's frame instead of blocking in
+lahar_window_frame_begin. The waits are driven by a LaharFramePoller, which you
+poll() from wherever your scheduler runs its ready work, ex: once per tick of the main
+loop. Polling never blocks: it calls lahar_window_frame_try_begin with a timeout of 0
+for every waiting frame, and resumes the coroutines whose frame began (or failed), on
+the thread that polled.
+
+    LaharFramePoller poller;
+
+    Task render(Lahar* lahar, LaharWindow* window) {
+        for (;;) {
+            uint32_t err = co_await lahar_co_frame_begin(poller, lahar, window);
+            if (err) { ... }
+
+            // Record, lahar_window_submit, lahar_window_present as usual
+        }
+    }
+
+    // Main loop
+    while (running) {
+        poll_input();
+        poll_network();
+        poller.poll();
+    }
+
+Include it after lahar.h, with the same configuration defines, or let it include
+lahar.h for you. Like the rest of lahar, a window must only be used from one thread at
+a time, so poll from the thread that owns the windows.
+
+*/
+
+#include <coroutine>
+#include <cstddef>
+
+// lahar.h's implementation isn't guarded against being included twice, so only pull it in if nothing has yet
+#ifndef LAHAR_H
+    #include "lahar.h"
+#endif
+
+class LaharFramePoller;
+
+/** What co_await lahar_co_frame_begin waits on. co_await gives the result of lahar_window_frame_begin.
+ * It lives in the awaiting coroutine's frame, so the poller's list of waits never allocates */
+class LaharFrameBeginAwaiter {
+public:
+    LaharFrameBeginAwaiter(LaharFramePoller& poller, Lahar* lahar, LaharWindow* window)
+        : poller(poller), lahar(lahar), window(window) {}
+
+    /** Begin straight away if the frame is ready, the coroutine doesn't suspend at all then */
+    bool await_ready() {
+        return try_begin();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    uint32_t await_resume() const {
+        return result;
+    }
+
+private:
+    friend class LaharFramePoller;
+
+    /** Try to begin the frame without blocking. False if it has to be tried again */
+    bool try_begin() {
+        result = lahar_window_frame_try_begin(lahar, window, 0);
+        return result != LAHAR_ERR_TIMEOUT;
+    }
+
+    LaharFramePoller& poller;
+    Lahar* lahar;
+    LaharWindow* window;
+    uint32_t result = LAHAR_ERR_SUCCESS;
+    std::coroutine_handle<> handle;
+    LaharFrameBeginAwaiter* next = nullptr;
+};
+
+/** The frames coroutines are waiting to begin. Not thread safe, see the top of the file */
+class LaharFramePoller {
+public:
+    LaharFramePoller() = default;
+    LaharFramePoller(const LaharFramePoller&) = delete;
+    LaharFramePoller& operator=(const LaharFramePoller&) = delete;
+
+    /** Try every waiting frame once, without blocking, and resume the coroutines whose frame began or failed.
+     * Coroutines that co_await another frame while being resumed are tried on the next poll
+     *
+     * @return How many coroutines were resumed
+     */
+    size_t poll() {
+        LaharFrameBeginAwaiter* waiting = head;
+        size_t resumed = 0;
+
+        head = nullptr;
+
+        while (waiting) {
+            // Resuming can destroy the awaiter with the coroutine frame, so take what's needed first
+            LaharFrameBeginAwaiter* awaiter = waiting;
+            waiting = awaiter->next;
+
+            if (awaiter->try_begin()) {
+                awaiter->handle.resume();
+                resumed++;
+            }
+            else {
+                awaiter->next = head;
+                head = awaiter;
+            }
+        }
+
+        return resumed;
+    }
+
+    /** True if no coroutine is waiting on a frame */
+    bool empty() const {
+        return head == nullptr;
+    }
+
+private:
+    friend class LaharFrameBeginAwaiter;
+
+    LaharFrameBeginAwaiter* head = nullptr;
+};
+
+inline void LaharFrameBeginAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    this->handle = handle;
+    next = poller.head;
+    poller.head = this;
+}
+
+/** co_await the start of a frame on a window, see the top of the file.
+ *
+ * @param poller The poller that resumes the coroutine once the frame began
+ * @param lahar The lahar instance
+ * @param window The window
+ * @return An awaitable giving what lahar_window_frame_begin would have returned
+ */
+inline LaharFrameBeginAwaiter lahar_co_frame_begin(LaharFramePoller& poller, Lahar* lahar, LaharWindow* window) {
+    return LaharFrameBeginAwaiter(poller, lahar, window);
+}
+
+#endif // LAHAR_CORO_HPP
+
+
+
+
+
+/*
+  Copyright (C) 2025 DalenPlanestrider
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
@@ -48,7 +48,7 @@ int main() {
         return 1;
     }
 
-    // Opt into having lahar make a primary buffer per swapchain image
+    // Opt into having lahar make a primary buffer per frame in flight
     // You can make your own after build, if you prefer
     lahar_builder_request_command_buffers(lahar);
 
@@ -72,7 +72,7 @@ int main() {
 
         lahar_window_frame_begin(lahar, window);
 
-        VkCommandBuffer cmd = winstate->commands[winstate->frame_index];
+        VkCommandBuffer cmd = winstate->commands[winstate->flight_index];
 
         VkCommandBufferBeginInfo begin_info = {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
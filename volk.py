@@ -72,6 +72,95 @@ def defined(key):
 def cdepends(key):
 	return re.sub(r'[a-zA-Z0-9_]+', lambda m: defined(m.group(0)), key).replace(',', ' || ').replace('+', ' && ')
 
+def subset_cond(group):
+	# The compile time group condition, with every term going through the LAHAR_VK_API_SUBSET filter
+	return re.sub(r'defined\((\w+)\)', r'LAHAR_VK_HAS(\1)', group)
+
+def subset_define(name):
+	# Always available to lahar's own code, whatever the subset says
+	required = ('VK_VERSION_1_0', 'VK_KHR_surface', 'VK_KHR_swapchain', 'VK_EXT_debug_utils')
+	if name in required:
+		allowed = ''
+	elif name.startswith('VK_VERSION_'):
+		major, minor = name[len('VK_VERSION_'):].split('_')
+		allowed = ' && (!defined(LAHAR_VK_API_SUBSET) || LAHAR_VK_API_SUBSET >= ' + str(int(major) * 100 + int(minor)) + ')'
+	else:
+		allowed = ' && (!defined(LAHAR_VK_API_SUBSET) || defined(LAHAR_VK_ALLOW_' + name + '))'
+
+	out = '#if defined(' + name + ')' + allowed + '\n'
+	out += '    #define LAHAR_VK_HAS_' + name + ' 1\n'
+	out += '#else\n'
+	out += '    #define LAHAR_VK_HAS_' + name + ' 0\n'
+	out += '#endif\n'
+	return out
+
+def extension_id(name):
+	return 'LAHAR_EXT_' + name[len('VK_'):]
+
+def extension_hash(seed, name):
+	# FNV-1a, with the seed mixed into the basis. Must match __lahar_ext_hash
+	hash = 2166136261 ^ seed
+	for byte in name.encode():
+		hash = ((hash ^ byte) * 16777619) & 0xffffffff
+	return hash
+
+def perfect_hash(names):
+	# Hash and displace: names are spread over buckets by their unseeded hash, then each bucket,
+	# biggest first, gets the first seed that sends all of its names to free slots
+	slot_count = 1
+	while slot_count < len(names) * 5 // 4:
+		slot_count *= 2
+	bucket_count = max(1, slot_count // 4)
+
+	buckets = [[] for _ in range(bucket_count)]
+	for (index, name) in enumerate(names):
+		buckets[extension_hash(0, name) & (bucket_count - 1)].append(index)
+
+	seeds = [0] * bucket_count
+	slots = [None] * slot_count
+
+	for bucket in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+		if not buckets[bucket]:
+			break
+		seed = 1
+		while True:
+			targets = [extension_hash(seed, names[index]) & (slot_count - 1) for index in buckets[bucket]]
+			if len(set(targets)) == len(targets) and all(slots[t] is None for t in targets):
+				break
+			seed += 1
+		assert seed < 0x10000
+		seeds[bucket] = seed
+		for (index, target) in zip(buckets[bucket], targets):
+			slots[target] = index
+
+	return (seeds, slots)
+
+def runtime_cond(group, level, ext_types):
+	# The compile time group condition, rewritten to check what lahar actually enabled.
+	# level is 'instance' or 'device', and picks which api version the check is against
+	def term(m):
+		name = m.group(1)
+		if name == 'VK_VERSION_1_0':
+			return 'true'
+		if name.startswith('VK_VERSION_'):
+			return 'lahar->' + level + '_version >= ' + name.replace('VK_VERSION_', 'VK_API_VERSION_')
+		if ext_types.get(name) == 'instance':
+			return 'lahar_extension_has_instance_id(lahar, ' + extension_id(name) + ')'
+		if level == 'instance':
+			return 'true' # device extensions aren't known while the instance is loaded
+		return 'lahar_extension_has_device_id(lahar, ' + extension_id(name) + ')'
+
+	cond = re.sub(r'defined\((\w+)\)', term, group)
+
+	prev = None
+	while prev != cond:
+		prev = cond
+		cond = cond.replace('(true)', 'true').replace('true && ', '').replace(' && true', '')
+		if cond.startswith('true || ') or cond.endswith(' || true'):
+			cond = 'true'
+
+	return cond
+
 if __name__ == "__main__":
 	specpath = "https://raw.githubusercontent.com/KhronosGroup/Vulkan-Docs/main/xml/vk.xml"
 
@@ -84,7 +173,13 @@ if __name__ == "__main__":
 
 	spec = parse_xml(specpath)
 
-	block_keys = ('DEVICE_TABLE', 'PROTOTYPES_H', 'PROTOTYPES_C', 'LOAD_LOADER', 'LOAD_INSTANCE', 'LOAD_DEVICE', 'LOAD_DEVICE_TABLE')
+	block_keys = ('SUBSET', 'DEVICE_TABLE', 'PROTOTYPES_H', 'PROTOTYPES_C', 'NAMES_TYPE', 'NAMES',
+		'ENTRIES_LOADER', 'ENTRIES_INSTANCE', 'ENTRIES_DEVICE', 'GATES_INSTANCE', 'GATES_DEVICE',
+		'LOAD_LOADER', 'LOAD_INSTANCE', 'LOAD_DEVICE', 'COUNTS',
+		'EXTENSION_IDS', 'EXTENSION_NAMES_TYPE', 'EXTENSION_NAMES', 'EXTENSION_OFFSETS', 'EXTENSION_HASH')
+
+	# Blocks that aren't split up by command group
+	flat_keys = ('SUBSET', 'COUNTS', 'EXTENSION_IDS', 'EXTENSION_NAMES_TYPE', 'EXTENSION_NAMES', 'EXTENSION_OFFSETS', 'EXTENSION_HASH')
 
 	blocks = {}
 
@@ -94,6 +189,7 @@ if __name__ == "__main__":
 
 	command_groups = OrderedDict()
 	instance_commands = set()
+	ext_types = {}
 
 	for feature in spec.findall('feature'):
 		api = feature.get('api')
@@ -109,6 +205,7 @@ if __name__ == "__main__":
 			continue
 		name = ext.get('name')
 		type = ext.get('type')
+		ext_types[name] = type
 		for req in ext.findall('require'):
 			key = defined(name)
 			if req.get('feature'): # old-style XML depends specification
@@ -169,16 +266,22 @@ if __name__ == "__main__":
 		blocks[key] = ''
 
 	devp = {}
+	subset_names = []
 
 	for (group, cmdnames) in command_groups.items():
-		ifdef = '#if ' + group + '\n'
+		for name in re.findall(r'defined\((\w+)\)', group):
+			if name not in subset_names:
+				subset_names.append(name)
 
-		for key in block_keys:
-			blocks[key] += ifdef
+	versions = sorted([name for name in subset_names if name.startswith('VK_VERSION_')])
+	extensions = sorted([name for name in subset_names if not name.startswith('VK_VERSION_')])
+	blocks['SUBSET'] = ''.join([subset_define(name) for name in versions + extensions])
 
-		devt = 0
-		devo = len(blocks['DEVICE_TABLE'])
+	# Every command gets a fixed slot in __lahar_vk_pfns, loader level first, then instance, then device.
+	# Device slots are in the same order as LaharDeviceTable, so one can be copied or loaded into the other
+	levels = OrderedDict()
 
+	for (group, cmdnames) in command_groups.items():
 		for name in sorted(cmdnames):
 			cmd = commands[name]
 			type = cmd.findtext('param[1]/type')
@@ -188,33 +291,66 @@ if __name__ == "__main__":
 			if name == 'vkGetDeviceProcAddr':
 				type = 'VkInstance'
 
-			"""
 			if is_descendant_type(types, type, 'VkDevice') and name not in instance_commands:
-				blocks['LOAD_DEVICE'] += '\t' + name + ' = (PFN_' + name + ')lahar_load(context, "' + name + '");\n'
-				blocks['DEVICE_TABLE'] += '\tPFN_' + name + ' ' + name + ';\n'
-				blocks['LOAD_DEVICE_TABLE'] += '\ttable->' + name + ' = (PFN_' + name + ')lahar_load(context, "' + name + '");\n'
-				devt += 1
+				levels[name] = 'DEVICE'
 			elif is_descendant_type(types, type, 'VkInstance'):
-				blocks['LOAD_INSTANCE'] += '\t' + name + ' = (PFN_' + name + ')lahar_load(context, "' + name + '");\n'
+				levels[name] = 'INSTANCE'
 			elif type != '':
-				blocks['LOAD_LOADER'] += '\t' + name + ' = (PFN_' + name + ')lahar_load(context, "' + name + '");\n'
-			"""
+				levels[name] = 'LOADER'
+			else:
+				levels[name] = None
 
-			if is_descendant_type(types, type, 'VkDevice') and name not in instance_commands:
-				blocks['LOAD_DEVICE'] += '\tlahar_load(lahar, ' + name + ');\n'
-				blocks['DEVICE_TABLE'] += '\tPFN_' + name + ' ' + name + ';\n'
-				blocks['LOAD_DEVICE_TABLE'] += '\ttable->' + name + ' = (PFN_' + name + ')lahar_load(lahar, ' + name + ');\n'
+	slot_counts = OrderedDict([('LOADER', 0), ('INSTANCE', 0), ('DEVICE', 0)])
+	for level in levels.values():
+		if level:
+			slot_counts[level] += 1
+
+	next_slot = {
+		'LOADER': 0,
+		'INSTANCE': slot_counts['LOADER'],
+		'DEVICE': slot_counts['LOADER'] + slot_counts['INSTANCE'],
+	}
+
+	for (group_index, (group, cmdnames)) in enumerate(command_groups.items()):
+		ifdef = '#if ' + subset_cond(group) + '\n'
+
+		for key in block_keys:
+			if key not in flat_keys:
+				blocks[key] += ifdef
+
+		devt = 0
+		devo = len(blocks['DEVICE_TABLE'])
+		group_levels = set()
+
+		for name in sorted(cmdnames):
+			level = levels[name]
+
+			if level:
+				slot = next_slot[level]
+				next_slot[level] += 1
+				group_levels.add(level)
+
+				blocks['NAMES_TYPE'] += '    char ' + name + '[sizeof("' + name + '")];\n'
+				blocks['NAMES'] += '    "' + name + '",\n'
+				blocks['ENTRIES_' + level] += '    { offsetof(LaharVkNames, ' + name + '), ' + str(group_index) + ', ' + str(slot) + ' },\n'
+				blocks['LOAD_' + level] += '    ' + name + ' = (PFN_' + name + ')__lahar_vk_pfns[' + str(slot) + '];\n'
+
+			if level == 'DEVICE':
+				blocks['DEVICE_TABLE'] += '    PFN_' + name + ' ' + name + ';\n'
 				devt += 1
-			elif is_descendant_type(types, type, 'VkInstance'):
-				blocks['LOAD_INSTANCE'] += '\tlahar_load(lahar, ' + name + ');\n'
-			elif type != '':
-				blocks['LOAD_LOADER'] += '\tlahar_load(lahar, ' + name + ');\n'
 
 			blocks['PROTOTYPES_H'] += 'extern PFN_' + name + ' ' + name + ';\n'
 			blocks['PROTOTYPES_C'] += 'PFN_' + name + ' ' + name + ';\n'
 
+		for level in ('INSTANCE', 'DEVICE'):
+			gate = runtime_cond(group, level.lower(), ext_types)
+			if level in group_levels and gate != 'true':
+				blocks['GATES_' + level] += '    gates[' + str(group_index) + '] = ' + gate + ';\n'
+
 		for key in block_keys:
-			if blocks[key].endswith(ifdef):
+			if key in flat_keys:
+				continue
+			elif blocks[key].endswith(ifdef):
 				blocks[key] = blocks[key][:-len(ifdef)]
 			elif key == 'DEVICE_TABLE':
 				devh = zlib.crc32(blocks[key][devo:].encode())
@@ -222,10 +358,39 @@ if __name__ == "__main__":
 				devp[devh] = True
 
 				blocks[key] += '#else\n'
-				blocks[key] += f'\tPFN_vkVoidFunction padding_{devh:x}[{devt}];\n'
-				blocks[key] += '#endif /* ' + group + ' */\n'
+				blocks[key] += f'    PFN_vkVoidFunction padding_{devh:x}[{devt}];\n'
+				blocks[key] += '#endif /* ' + subset_cond(group) + ' */\n'
 			else:
-				blocks[key] += '#endif /* ' + group + ' */\n'
+				blocks[key] += '#endif /* ' + subset_cond(group) + ' */\n'
+
+	blocks['COUNTS'] += '#define LAHAR_VK_GROUP_COUNT ' + str(len(command_groups)) + '\n'
+	blocks['COUNTS'] += '#define LAHAR_VK_INSTANCE_SLOT_BASE ' + str(slot_counts['LOADER']) + '\n'
+	blocks['COUNTS'] += '#define LAHAR_VK_DEVICE_SLOT_BASE ' + str(slot_counts['LOADER'] + slot_counts['INSTANCE']) + '\n'
+	blocks['COUNTS'] += '#define LAHAR_VK_SLOT_COUNT ' + str(sum(slot_counts.values())) + '\n'
+
+	# Every extension in the registry gets an id, in name order, whether or not the headers or the subset have it
+	ext_names = sorted(ext_types.keys())
+	(seeds, slots) = perfect_hash(ext_names)
+
+	for name in ext_names:
+		blocks['EXTENSION_IDS'] += '    ' + extension_id(name) + ',\n'
+		# The vulkan headers #define every extension name, so the members go without the VK_
+		blocks['EXTENSION_NAMES_TYPE'] += '    char ' + name[len('VK_'):] + '[sizeof("' + name + '")];\n'
+		blocks['EXTENSION_NAMES'] += '    "' + name + '",\n'
+		blocks['EXTENSION_OFFSETS'] += '    offsetof(LaharExtensionNames, ' + name[len('VK_'):] + '),\n'
+
+	def table(values):
+		return ''.join(['    ' + ', '.join(values[i:i + 16]) + ',\n' for i in range(0, len(values), 16)])
+
+	blocks['EXTENSION_HASH'] += '#define LAHAR_EXT_HASH_BUCKETS ' + str(len(seeds)) + '\n'
+	blocks['EXTENSION_HASH'] += '#define LAHAR_EXT_HASH_SLOTS ' + str(len(slots)) + '\n\n'
+	blocks['EXTENSION_HASH'] += 'static const uint16_t __lahar_ext_hash_seeds[LAHAR_EXT_HASH_BUCKETS] = {\n'
+	blocks['EXTENSION_HASH'] += table([str(seed) for seed in seeds])
+	blocks['EXTENSION_HASH'] += '};\n\n'
+	blocks['EXTENSION_HASH'] += '// The id in each slot, or 0xffff for an empty one\n'
+	blocks['EXTENSION_HASH'] += 'static const uint16_t __lahar_ext_hash_slots[LAHAR_EXT_HASH_SLOTS] = {\n'
+	blocks['EXTENSION_HASH'] += table(['0xffff' if slot is None else str(slot) for slot in slots])
+	blocks['EXTENSION_HASH'] += '};\n'
 
 	#patch_file('volk.h', blocks)
 	#patch_file('volk.c', blocks)